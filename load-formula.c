@@ -0,0 +1,1657 @@
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// a ppkg formula is a one-level YAML mapping whose values all are scalars.
+// this program parses such a file in one pass and prints the wanted values as shell assignments which can be eval'd.
+// anything beyond that subset of YAML (flow collections, anchors, aliases, tags, nested collections, multi-line quoted scalars, etc)
+// is reported via exit status 100, then the caller is supposed to fall back to yq.
+//
+// with --json or --yaml, this program reads <PKGNAME>\t<FORMULA-FILEPATH> lines from stdin and streams them as one JSON array
+// or as YAML documents, one formula at a time. this is what ppkg ls-available -v and ppkg search -v are built on.
+
+#define UNSUPPORTED 100
+
+typedef struct {
+    const char * p; // start of this line
+    size_t n;       // length of this line, excluding '\n'
+} Line;
+
+typedef struct {
+    char * p;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static int buffer_append(Buffer * b, const char * s, size_t n) {
+    if (b->length + n + 1 > b->capacity) {
+        size_t capacity = b->capacity == 0 ? 256 : b->capacity;
+
+        while (b->length + n + 1 > capacity) {
+            capacity <<= 1;
+        }
+
+        char * p = realloc(b->p, capacity);
+
+        if (p == NULL) {
+            perror(NULL);
+            return -1;
+        }
+
+        b->p = p;
+        b->capacity = capacity;
+    }
+
+    memcpy(b->p + b->length, s, n);
+    b->length += n;
+    b->p[b->length] = '\0';
+    return 0;
+}
+
+static size_t count_leading_spaces(const Line * line) {
+    size_t i = 0;
+
+    while (i < line->n && line->p[i] == ' ') {
+        i++;
+    }
+
+    return i;
+}
+
+static int is_blank(const Line * line) {
+    for (size_t i = 0; i < line->n; i++) {
+        if (line->p[i] != ' ' && line->p[i] != '\t' && line->p[i] != '\r') {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int is_comment(const Line * line) {
+    size_t i = count_leading_spaces(line);
+    return i < line->n && line->p[i] == '#';
+}
+
+// strip trailing whitespaces and the trailing comment of a plain scalar
+static size_t plain_scalar_length(const char * p, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] == '#' && (i == 0 || p[i - 1] == ' ' || p[i - 1] == '\t')) {
+            n = i;
+            break;
+        }
+    }
+
+    while (n > 0 && (p[n - 1] == ' ' || p[n - 1] == '\t' || p[n - 1] == '\r')) {
+        n--;
+    }
+
+    return n;
+}
+
+// the separator between two adjacent lines of a folded scalar
+// https://yaml.org/spec/1.2.2/#813-folded-style
+static int fold(Buffer * b, size_t emptyLines, int prevMoreIndented, int thisMoreIndented) {
+    if (prevMoreIndented || thisMoreIndented) {
+        emptyLines++;
+    }
+
+    if (emptyLines == 0) {
+        return buffer_append(b, " ", 1);
+    }
+
+    for (size_t i = 0; i < emptyLines; i++) {
+        if (buffer_append(b, "\n", 1) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// https://yaml.org/spec/1.2.2/#81-block-scalar-headers
+static int parse_block_scalar(const Line * lines, size_t lineCount, size_t * index, const char * header, size_t headerLength, Buffer * b) {
+    const char style = header[0];
+
+    size_t indent = 0;
+
+    size_t i = 1;
+
+    for (; i < headerLength; i++) {
+        const char c = header[i];
+
+        if (c == '-' || c == '+') {
+            // chomping does not matter, trailing newlines are always stripped as the shell command substitution does
+            continue;
+        }
+
+        if (c >= '1' && c <= '9') {
+            indent = c - '0';
+            continue;
+        }
+
+        break;
+    }
+
+    if (plain_scalar_length(header + i, headerLength - i) != 0) {
+        return UNSUPPORTED;
+    }
+
+    size_t j = *index + 1;
+
+    if (indent == 0) {
+        for (size_t k = j; k < lineCount; k++) {
+            if (!is_blank(&lines[k])) {
+                indent = count_leading_spaces(&lines[k]);
+                break;
+            }
+        }
+
+        if (indent == 0) {
+            return 0;
+        }
+    }
+
+    size_t emptyLines = 0;
+
+    int prevMoreIndented = 0;
+    int hasContent = 0;
+
+    for (; j < lineCount; j++) {
+        const Line * line = &lines[j];
+
+        if (is_blank(line)) {
+            if (line->n > indent && style == '|') {
+                // a whitespace-only line of a literal scalar keeps its spaces beyond the indentation
+                if (hasContent) {
+                    for (size_t k = 0; k <= emptyLines; k++) {
+                        if (buffer_append(b, "\n", 1) != 0) return -1;
+                    }
+                } else {
+                    for (size_t k = 0; k < emptyLines; k++) {
+                        if (buffer_append(b, "\n", 1) != 0) return -1;
+                    }
+                }
+
+                if (buffer_append(b, line->p + indent, line->n - indent) != 0) return -1;
+
+                emptyLines = 0;
+                hasContent = 1;
+            } else {
+                emptyLines++;
+            }
+
+            continue;
+        }
+
+        size_t spaces = count_leading_spaces(line);
+
+        if (spaces < indent) {
+            break;
+        }
+
+        const char * p = line->p + indent;
+        size_t      n = line->n - indent;
+
+        if (n > 0 && p[n - 1] == '\r') {
+            n--;
+        }
+
+        if (style == '|') {
+            size_t newlines = hasContent ? emptyLines + 1 : emptyLines;
+
+            for (size_t k = 0; k < newlines; k++) {
+                if (buffer_append(b, "\n", 1) != 0) return -1;
+            }
+        } else {
+            const int thisMoreIndented = (p[0] == ' ' || p[0] == '\t');
+
+            if (hasContent) {
+                if (fold(b, emptyLines, prevMoreIndented, thisMoreIndented) != 0) return -1;
+            } else {
+                for (size_t k = 0; k < emptyLines; k++) {
+                    if (buffer_append(b, "\n", 1) != 0) return -1;
+                }
+            }
+
+            prevMoreIndented = thisMoreIndented;
+        }
+
+        if (buffer_append(b, p, n) != 0) return -1;
+
+        emptyLines = 0;
+        hasContent = 1;
+    }
+
+    *index = j - 1;
+    return 0;
+}
+
+// https://yaml.org/spec/1.2.2/#731-double-quoted-style
+static int parse_double_quoted_scalar(const char * p, size_t n, Buffer * b) {
+    for (size_t i = 1; i < n; i++) {
+        const char c = p[i];
+
+        if (c == '"') {
+            if (plain_scalar_length(p + i + 1, n - i - 1) != 0) {
+                return UNSUPPORTED;
+            }
+
+            return 0;
+        }
+
+        if (c != '\\') {
+            if (buffer_append(b, &p[i], 1) != 0) return -1;
+            continue;
+        }
+
+        if (++i == n) {
+            break;
+        }
+
+        char e;
+
+        switch (p[i]) {
+            case '0':  e = '\0'; break;
+            case 'a':  e = '\a'; break;
+            case 'b':  e = '\b'; break;
+            case 't':  e = '\t'; break;
+            case 'n':  e = '\n'; break;
+            case 'v':  e = '\v'; break;
+            case 'f':  e = '\f'; break;
+            case 'r':  e = '\r'; break;
+            case 'e':  e = '\033'; break;
+            case ' ':  e = ' ';  break;
+            case '"':  e = '"';  break;
+            case '/':  e = '/';  break;
+            case '\\': e = '\\'; break;
+            case '\t': e = '\t'; break;
+            default:   return UNSUPPORTED;
+        }
+
+        // a shell variable can not hold NUL
+        if (e == '\0') {
+            return UNSUPPORTED;
+        }
+
+        if (buffer_append(b, &e, 1) != 0) return -1;
+    }
+
+    // multi-line double-quoted scalar
+    return UNSUPPORTED;
+}
+
+// https://yaml.org/spec/1.2.2/#732-single-quoted-style
+static int parse_single_quoted_scalar(const char * p, size_t n, Buffer * b) {
+    for (size_t i = 1; i < n; i++) {
+        if (p[i] != '\'') {
+            if (buffer_append(b, &p[i], 1) != 0) return -1;
+            continue;
+        }
+
+        if (i + 1 < n && p[i + 1] == '\'') {
+            if (buffer_append(b, "'", 1) != 0) return -1;
+            i++;
+            continue;
+        }
+
+        if (plain_scalar_length(p + i + 1, n - i - 1) != 0) {
+            return UNSUPPORTED;
+        }
+
+        return 0;
+    }
+
+    // multi-line single-quoted scalar
+    return UNSUPPORTED;
+}
+
+// https://yaml.org/spec/1.2.2/#733-plain-style
+static int parse_plain_scalar(const Line * lines, size_t lineCount, size_t * index, const char * p, size_t n, Buffer * b, int * isNull) {
+    n = plain_scalar_length(p, n);
+
+    if (buffer_append(b, p, n) != 0) return -1;
+
+    size_t emptyLines = 0;
+
+    size_t j = *index + 1;
+
+    for (; j < lineCount; j++) {
+        const Line * line = &lines[j];
+
+        if (is_blank(line)) {
+            emptyLines++;
+            continue;
+        }
+
+        if (line->p[0] != ' ') {
+            break;
+        }
+
+        if (is_comment(line)) {
+            // a comment line terminates a multi-line plain scalar
+            j++;
+            break;
+        }
+
+        size_t spaces = count_leading_spaces(line);
+
+        const char * q = line->p + spaces;
+        size_t       m = plain_scalar_length(q, line->n - spaces);
+
+        if (b->length == 0) {
+            // the value starts on the next line, it might be a nested collection
+            if (q[0] == '-' || q[0] == '[' || q[0] == '{' || q[0] == '&' || q[0] == '*' || q[0] == '!' || q[0] == '"' || q[0] == '\'' || q[0] == '|' || q[0] == '>') {
+                return UNSUPPORTED;
+            }
+
+            for (size_t k = 0; k + 1 < m; k++) {
+                if (q[k] == ':' && q[k + 1] == ' ') {
+                    return UNSUPPORTED;
+                }
+            }
+
+            if (m > 0 && q[m - 1] == ':') {
+                return UNSUPPORTED;
+            }
+        } else {
+            if (fold(b, emptyLines, 0, 0) != 0) return -1;
+        }
+
+        if (buffer_append(b, q, m) != 0) return -1;
+
+        emptyLines = 0;
+    }
+
+    *index = j - 1;
+
+    // https://yaml.org/spec/1.2.2/#1021-tags
+    if (b->length == 0) {
+        *isNull = 1;
+    } else if (b->length == 1) {
+        *isNull = b->p[0] == '~';
+    } else if (b->length == 4) {
+        *isNull = strcmp(b->p, "null") == 0 || strcmp(b->p, "Null") == 0 || strcmp(b->p, "NULL") == 0;
+    }
+
+    return 0;
+}
+
+typedef struct {
+    const char * key;  // the formula key
+    const char * name; // the shell variable name
+    Buffer value;
+    int isSet;
+} Field;
+
+static Field * lookup(Field * fields, size_t fieldCount, const char * key, size_t keyLength) {
+    for (size_t i = 0; i < fieldCount; i++) {
+        if (strncmp(fields[i].key, key, keyLength) == 0 && fields[i].key[keyLength] == '\0') {
+            return &fields[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void print_assignment(const Field * field) {
+    printf("%s='", field->name);
+
+    for (size_t i = 0; i < field->value.length; i++) {
+        if (field->value.p[i] == '\'') {
+            fputs("'\\''", stdout);
+        } else {
+            putchar(field->value.p[i]);
+        }
+    }
+
+    fputs("'\n", stdout);
+}
+
+static int load(const char * filepath, char * content, size_t contentLength, Field * fields, size_t fieldCount) {
+    size_t lineCount = 1;
+
+    for (size_t i = 0; i < contentLength; i++) {
+        if (content[i] == '\n') {
+            lineCount++;
+        }
+    }
+
+    Line * lines = calloc(lineCount, sizeof(Line));
+
+    if (lines == NULL) {
+        perror(NULL);
+        return -1;
+    }
+
+    lineCount = 0;
+
+    const char * p = content;
+
+    for (size_t i = 0; i <= contentLength; i++) {
+        if (i == contentLength || content[i] == '\n') {
+            lines[lineCount].p = p;
+            lines[lineCount].n = content + i - p;
+            lineCount++;
+            p = content + i + 1;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////
+
+    for (size_t i = 0; i < fieldCount; i++) {
+        fields[i].isSet = 0;
+    }
+
+    int ret = 0;
+
+    int hasKey = 0;
+
+    for (size_t i = 0; i < lineCount; i++) {
+        const Line * line = &lines[i];
+
+        if (is_blank(line) || is_comment(line)) {
+            continue;
+        }
+
+        if (line->n >= 3 && strncmp(line->p, "---", 3) == 0 && (line->n == 3 || line->p[3] == ' ' || line->p[3] == '\r')) {
+            if (!hasKey) {
+                continue;
+            }
+
+            // multiple documents
+            ret = UNSUPPORTED;
+            break;
+        }
+
+        if (line->n >= 3 && strncmp(line->p, "...", 3) == 0) {
+            break;
+        }
+
+        if (line->p[0] == ' ' || line->p[0] == '\t') {
+            fprintf(stderr, "%s:%zu: unexpected indentation.\n", filepath, i + 1);
+            ret = UNSUPPORTED;
+            break;
+        }
+
+        ///////////////////////////////////////////////////////
+
+        size_t keyLength = 0;
+
+        while (keyLength < line->n && line->p[keyLength] != ':') {
+            const char c = line->p[keyLength];
+
+            if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '+')) {
+                keyLength = 0;
+                break;
+            }
+
+            keyLength++;
+        }
+
+        if (keyLength == 0 || keyLength == line->n || (keyLength + 1 < line->n && line->p[keyLength + 1] != ' ' && line->p[keyLength + 1] != '\t' && line->p[keyLength + 1] != '\r')) {
+            fprintf(stderr, "%s:%zu: not a 'KEY: VALUE' line.\n", filepath, i + 1);
+            ret = UNSUPPORTED;
+            break;
+        }
+
+        hasKey = 1;
+
+        Field * field = lookup(fields, fieldCount, line->p, keyLength);
+
+        if (field == NULL) {
+            // skip the value of this unwanted key, including nested collections and multi-line scalars
+            while (i + 1 < lineCount && (is_blank(&lines[i + 1]) || lines[i + 1].p[0] == ' ' || lines[i + 1].p[0] == '\t')) {
+                i++;
+            }
+
+            continue;
+        }
+
+        ///////////////////////////////////////////////////////
+
+        const char * v = line->p + keyLength + 1;
+        size_t       n = line->n - keyLength - 1;
+
+        while (n > 0 && (v[0] == ' ' || v[0] == '\t')) {
+            v++;
+            n--;
+        }
+
+        Buffer * b = &field->value;
+
+        b->length = 0;
+
+        if (b->p != NULL) {
+            b->p[0] = '\0';
+        }
+
+        int isNull = 0;
+
+        switch (n == 0 ? '\0' : v[0]) {
+            case '|':
+            case '>':
+                ret = parse_block_scalar(lines, lineCount, &i, v, n, b);
+                break;
+            case '"':
+                ret = parse_double_quoted_scalar(v, n, b);
+                break;
+            case '\'':
+                ret = parse_single_quoted_scalar(v, n, b);
+                break;
+            case '[': case '{': case '&': case '*': case '!': case '%': case '@': case '`':
+                ret = UNSUPPORTED;
+                break;
+            case '-':
+                if (n == 1 || v[1] == ' ') {
+                    ret = UNSUPPORTED;
+                    break;
+                }
+                // fall through
+            default:
+                ret = parse_plain_scalar(lines, lineCount, &i, v, n, b, &isNull);
+        }
+
+        if (ret != 0) {
+            if (ret == UNSUPPORTED) {
+                fprintf(stderr, "%s:%zu: the value of %.*s is not supported.\n", filepath, i + 1, (int)keyLength, line->p);
+            }
+
+            break;
+        }
+
+        // as the shell command substitution does
+        while (b->length > 0 && b->p[b->length - 1] == '\n') {
+            b->p[--b->length] = '\0';
+        }
+
+        field->isSet = !isNull;
+    }
+
+    free(lines);
+
+    return ret;
+}
+
+// returns 0 on success, otherwise the exit status which main should return
+static int read_file(const char * filepath, char ** content, size_t * contentLength) {
+    int fd = open(filepath, O_RDONLY);
+
+    if (fd == -1) {
+        perror(filepath);
+        return 3;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) == -1) {
+        perror(filepath);
+        close(fd);
+        return 4;
+    }
+
+    ///////////////////////////////////////////////////////////
+
+    char * p = malloc(st.st_size + 1);
+
+    if (p == NULL) {
+        perror(NULL);
+        close(fd);
+        return 5;
+    }
+
+    size_t n = 0;
+
+    while (n < (size_t)st.st_size) {
+        ssize_t readBytes = read(fd, p + n, st.st_size - n);
+
+        if (readBytes == -1) {
+            perror(filepath);
+            free(p);
+            close(fd);
+            return 6;
+        }
+
+        if (readBytes == 0) {
+            break;
+        }
+
+        n += readBytes;
+    }
+
+    close(fd);
+
+    p[n] = '\0';
+
+    ///////////////////////////////////////////////////////////
+
+    // a shell variable can not hold NUL
+    if (memchr(p, '\0', n) != NULL) {
+        fprintf(stderr, "%s: contains NUL character.\n", filepath);
+        free(p);
+        return UNSUPPORTED;
+    }
+
+    *content = p;
+    *contentLength = n;
+
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////
+
+// the keys and the order of ppkg info-available <PACKAGE-NAME> --json
+static const char * const JSON_KEYS[] = {
+    "pkgname", "pkgtype", "version", "license", "summary",
+    "web-url", "git-url", "git-sha", "git-ref", "git-nth",
+    "src-url", "src-uri", "src-sha",
+    "fix-url", "fix-uri", "fix-sha",
+    "res-url", "res-uri", "res-sha",
+    "patches", "reslist",
+    "dep-pkg", "dep-lib", "dep-upp", "dep-pym", "dep-plm",
+    "bsystem", "binbstd", "ccflags", "xxflags", "ppflags", "ldflags",
+    "parallel", "unity", "developer",
+    "onstart", "onready", "doextra", "do12345", "dopatch", "prepare", "install", "dotweak", "dobolt", "caveats",
+    NULL
+};
+
+// the keys and the order of ppkg info-available <PACKAGE-NAME> --yaml
+static const char * const YAML_KEYS[] = {
+    "pkgname", "pkgtype", "version", "license", "summary",
+    "web-url", "git-url", "git-sha", "git-ref", "git-nth",
+    "src-url", "src-uri", "src-sha",
+    "fix-url", "fix-uri", "fix-sha",
+    "res-url", "res-uri", "res-sha",
+    "dep-pkg", "dep-lib", "dep-upp", "dep-pym", "dep-plm",
+    "bsystem", "binbstd", "ppflags", "ccflags", "xxflags", "ldflags",
+    "parallel", "unity", "installed",
+    NULL
+};
+
+static char * copy_string(const char * s, size_t n) {
+    char * p = malloc(n + 1);
+
+    if (p == NULL) {
+        perror(NULL);
+        return NULL;
+    }
+
+    memcpy(p, s, n);
+    p[n] = '\0';
+    return p;
+}
+
+// read a line without the trailing '\n', returns 1 on EOF
+static int read_line(FILE * fp, Buffer * b) {
+    char buf[1024];
+
+    b->length = 0;
+
+    for (;;) {
+        if (fgets(buf, sizeof(buf), fp) == NULL) {
+            return b->length == 0 ? 1 : 0;
+        }
+
+        size_t n = strlen(buf);
+
+        if (n > 0 && buf[n - 1] == '\n') {
+            return buffer_append(b, buf, n - 1);
+        }
+
+        if (buffer_append(b, buf, n) != 0) {
+            return -1;
+        }
+    }
+}
+
+static Field * get(Field * fields, size_t fieldCount, const char * key) {
+    return lookup(fields, fieldCount, key, strlen(key));
+}
+
+static int set(Field * field, const char * s, size_t n) {
+    field->value.length = 0;
+    field->isSet = 1;
+    return buffer_append(&field->value, s, n);
+}
+
+static int has_suffix(const Buffer * b, const char * suffix) {
+    size_t n = strlen(suffix);
+    return b->length >= n && memcmp(b->p + b->length - n, suffix, n) == 0;
+}
+
+static void remove_first(Buffer * b, const char * s) {
+    char * p = strstr(b->p, s);
+
+    if (p != NULL) {
+        size_t n = strlen(s);
+        memmove(p, p + n, b->p + b->length - p - n + 1);
+        b->length -= n;
+    }
+}
+
+// the same as __guess_version_from_src_url in ppkg
+static int guess_version_from_src_url(const Buffer * srcUrl, Buffer * version) {
+    const char * p = strrchr(srcUrl->p, '/');
+
+    p = (p == NULL) ? srcUrl->p : p + 1;
+
+    Buffer b = {0};
+
+    if (buffer_append(&b, p, strlen(p)) != 0) return -1;
+
+    for (size_t i = 0; i < b.length; i++) {
+        if (b.p[i] == '_' || b.p[i] == '@') {
+            b.p[i] = '-';
+        }
+    }
+
+    static const char * const suffixes[] = { ".tar.gz", ".tar.lz", ".tar.xz", ".tar.bz2", ".tgz", ".tlz", ".txz", ".zip" };
+
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        if (has_suffix(&b, suffixes[i])) {
+            b.length -= strlen(suffixes[i]);
+            b.p[b.length] = '\0';
+        }
+    }
+
+    remove_first(&b, "-stable");
+    remove_first(&b, "-source");
+
+    if (has_suffix(&b, "-src") || has_suffix(&b, ".src")) {
+        b.length -= 4;
+        b.p[b.length] = '\0';
+    }
+
+    remove_first(&b, ".orig");
+
+    const char * q = strrchr(b.p, '-');
+
+    q = (q == NULL) ? b.p : q + 1;
+
+    if (q[0] == 'v') {
+        q++;
+    }
+
+    int ret = buffer_append(version, q, strlen(q));
+
+    free(b.p);
+
+    return ret;
+}
+
+static int is_empty(const Field * field) {
+    return !field->isSet || field->value.length == 0;
+}
+
+// append a word to a space-separated list
+static int append_word(Field * field, const char * word) {
+    if (!field->isSet) {
+        field->value.length = 0;
+        field->isSet = 1;
+    }
+
+    if (field->value.length > 0 && buffer_append(&field->value, " ", 1) != 0) {
+        return -1;
+    }
+
+    return buffer_append(&field->value, word, strlen(word));
+}
+
+// whether the file type that filetype_from_url in ppkg gives for the given url is one of .zip .txz .tgz .tlz .tbz2 .crate, which are unpacked by bsdtar
+static int is_bsdtar_filetype(const char * url, size_t n) {
+    const char * q = memchr(url, '?', n);
+
+    if (q != NULL) {
+        n = q - url;
+    }
+
+    const char * fname = url;
+
+    for (size_t i = 0; i < n; i++) {
+        if (url[i] == '/') {
+            fname = url + i + 1;
+        }
+    }
+
+    n -= fname - url;
+
+    static const char * const suffixes[] = { ".tar.gz", ".tar.lz", ".tar.xz", ".tar.bz2", ".tgz", ".tlz", ".txz", ".tbz2", ".zip", ".crate" };
+
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        size_t m = strlen(suffixes[i]);
+
+        if (n >= m && memcmp(fname + n - m, suffixes[i], m) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// the same as the case statement on the first word of every line of the install mapping in ppkg
+static const char * bsystem_from_install(const Buffer * install) {
+    static const char * const words[]    = { "configure", "cmakew", "xmakew", "mesonw", "gmakew", "cargow", "go",  "gow", "waf", "cabal_v2_install" };
+    static const char * const bsystems[] = { "configure", "cmake",  "xmake",  "meson",  "gmake",  "cargo",  "go",  "go",  "waf", "cabal" };
+
+    const char * p = install->p;
+    const char * end = install->p + install->length;
+
+    while (p < end) {
+        const char * eol = memchr(p, '\n', end - p);
+
+        if (eol == NULL) {
+            eol = end;
+        }
+
+        while (p < eol && strchr(" \t\v\f\r", *p) != NULL) {
+            p++;
+        }
+
+        const char * sp = memchr(p, ' ', eol - p);
+
+        if (sp == NULL) {
+            sp = eol;
+        }
+
+        // the first field of a line is split by the shell once more, on tabs
+        while (p < sp) {
+            const char * q = p;
+
+            while (q < sp && *q != '\t') {
+                q++;
+            }
+
+            for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+                if ((size_t)(q - p) == strlen(words[i]) && memcmp(p, words[i], q - p) == 0) {
+                    return bsystems[i];
+                }
+            }
+
+            p = q + 1;
+        }
+
+        p = eol + 1;
+    }
+
+    return NULL;
+}
+
+// fill in the values which ppkg derives while loading a formula and which are cheap to derive without running anything.
+// a formula that ppkg would reject is reported as UNSUPPORTED, so that the caller falls back to ppkg which prints why.
+// see __load_formula_of_the_given_package in ppkg
+static int derive(const char * pkgname, Field * fields, size_t fieldCount) {
+    Field * pkgtype  = get(fields, fieldCount, "pkgtype");
+    Field * version  = get(fields, fieldCount, "version");
+    Field * summary  = get(fields, fieldCount, "summary");
+    Field * webUrl   = get(fields, fieldCount, "web-url");
+    Field * gitUrl   = get(fields, fieldCount, "git-url");
+    Field * gitNth   = get(fields, fieldCount, "git-nth");
+    Field * srcUrl   = get(fields, fieldCount, "src-url");
+    Field * srcSha   = get(fields, fieldCount, "src-sha");
+    Field * fixUrl   = get(fields, fieldCount, "fix-url");
+    Field * fixSha   = get(fields, fieldCount, "fix-sha");
+    Field * resUrl   = get(fields, fieldCount, "res-url");
+    Field * resSha   = get(fields, fieldCount, "res-sha");
+    Field * patches  = get(fields, fieldCount, "patches");
+    Field * reslist  = get(fields, fieldCount, "reslist");
+    Field * depUpp   = get(fields, fieldCount, "dep-upp");
+    Field * depPym   = get(fields, fieldCount, "dep-pym");
+    Field * depPlm   = get(fields, fieldCount, "dep-plm");
+    Field * bsystem  = get(fields, fieldCount, "bsystem");
+    Field * binbstd  = get(fields, fieldCount, "binbstd");
+    Field * install  = get(fields, fieldCount, "install");
+    Field * parallel = get(fields, fieldCount, "parallel");
+    Field * unity    = get(fields, fieldCount, "unity");
+
+    if (is_empty(summary)) {
+        return UNSUPPORTED;
+    }
+
+    if ((!is_empty(fixUrl) && !is_empty(patches)) || (!is_empty(resUrl) && !is_empty(reslist))) {
+        return UNSUPPORTED;
+    }
+
+    if (!is_empty(gitNth) && strspn(gitNth->value.p, "0123456789") != gitNth->value.length) {
+        return UNSUPPORTED;
+    }
+
+    if (is_empty(pkgtype)) {
+        size_t n = strlen(pkgname);
+
+        if (strncmp(pkgname, "lib", 3) == 0 || (n >= 3 && strcmp(pkgname + n - 3, "lib") == 0) || strncmp(pkgname, "xorg-lib", 8) == 0) {
+            if (set(pkgtype, "lib", 3) != 0) return -1;
+        } else {
+            if (set(pkgtype, "exe", 3) != 0) return -1;
+        }
+    }
+
+    int timeVersioned = 0;
+
+    int needGit  = 0;
+    int needCurl = 0;
+    int needBtar = 0;
+
+    // whether the source is unpacked by bsdtar, the resources and the patches are judged by it as well
+    int srcIsBtar = 0;
+
+    if (!is_empty(srcUrl)) {
+        const char * url = srcUrl->value.p;
+
+        if (strncmp(url, "dir://", 6) == 0) {
+            timeVersioned = 1;
+        } else if (strncmp(url, "file://", 7) == 0) {
+            timeVersioned = 1;
+            srcIsBtar = is_bsdtar_filetype(url, srcUrl->value.length);
+        } else {
+            srcIsBtar = is_bsdtar_filetype(url, srcUrl->value.length);
+
+            if (is_empty(srcSha)) {
+                return UNSUPPORTED;
+            }
+
+            if (is_empty(gitUrl)) {
+                static const char * const prefixes[] = { "https://github.com/", "https://github.com/", "https://gitlab.com/" };
+                static const char * const infixes[]  = { "/releases/", "/archive/", "/-/archive/" };
+
+                for (int i = 0; i < 3; i++) {
+                    if (strncmp(url, prefixes[i], strlen(prefixes[i])) == 0) {
+                        const char * p = strstr(url, infixes[i]);
+
+                        if (p != NULL) {
+                            if (set(gitUrl, url, p - url) != 0) return -1;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (is_empty(version)) {
+                version->value.length = 0;
+                version->isSet = 1;
+
+                if (guess_version_from_src_url(&srcUrl->value, &version->value) != 0) return -1;
+
+                if (version->value.length == 0) {
+                    return UNSUPPORTED;
+                }
+            }
+
+            needCurl = 1;
+            needBtar = srcIsBtar;
+        }
+    } else if (!is_empty(gitUrl)) {
+        timeVersioned = 1;
+        needGit = 1;
+    }
+
+    if (timeVersioned && is_empty(version)) {
+        char buf[16];
+
+        time_t t = time(NULL);
+
+        size_t n = strftime(buf, sizeof(buf), "%Y.%m.%d", gmtime(&t));
+
+        if (set(version, buf, n) != 0) return -1;
+    }
+
+    if (is_empty(webUrl) && is_empty(gitUrl)) {
+        return UNSUPPORTED;
+    }
+
+    if (!is_empty(fixUrl)) {
+        if (is_empty(fixSha)) {
+            return UNSUPPORTED;
+        }
+
+        needCurl = 1;
+        needBtar |= srcIsBtar;
+    }
+
+    if (!is_empty(resUrl)) {
+        if (is_empty(resSha)) {
+            return UNSUPPORTED;
+        }
+
+        needCurl = 1;
+        needBtar |= srcIsBtar;
+    }
+
+    // every whitespace-separated <SHA256>|<URL>[|...] item of patches and reslist
+    const Field * lists[] = { patches, reslist };
+
+    for (int i = 0; i < 2; i++) {
+        if (is_empty(lists[i])) {
+            continue;
+        }
+
+        const char * p = lists[i]->value.p;
+
+        for (;;) {
+            p += strspn(p, " \t\n");
+
+            if (*p == '\0') {
+                break;
+            }
+
+            size_t n = strcspn(p, " \t\n");
+
+            const char * bar = memchr(p, '|', n);
+
+            size_t shaLength = bar == NULL ? n : (size_t)(bar - p);
+
+            if (shaLength != 64) {
+                return UNSUPPORTED;
+            }
+
+            if (bar != NULL) {
+                const char * url = bar + 1;
+
+                size_t urlLength = n - shaLength - 1;
+
+                const char * bar2 = memchr(url, '|', urlLength);
+
+                if (bar2 != NULL) {
+                    urlLength = bar2 - url;
+                }
+
+                needBtar |= is_bsdtar_filetype(url, urlLength);
+            }
+
+            needCurl = 1;
+
+            p += n;
+        }
+    }
+
+    if (needGit  && append_word(depUpp, "git")    != 0) return -1;
+    if (needCurl && append_word(depUpp, "curl")   != 0) return -1;
+    if (needBtar && append_word(depUpp, "bsdtar") != 0) return -1;
+
+    ///////////////////////////////////////////////////////////
+
+    if (is_empty(bsystem)) {
+        if (is_empty(install)) {
+            return UNSUPPORTED;
+        }
+
+        const char * s = bsystem_from_install(&install->value);
+
+        if (s != NULL && set(bsystem, s, strlen(s)) != 0) return -1;
+    }
+
+    int useAutogen = 0, useAutotools = 0, useConfigure = 0, useCmake = 0, useXmake = 0, useMeson = 0, useNinja = 0;
+    int useGmake = 0, useRake = 0, useCargo = 0, useCabal = 0, useGo = 0, useWaf = 0;
+
+    char master[32] = "";
+
+    if (!is_empty(bsystem)) {
+        const char * p = bsystem->value.p;
+
+        size_t n = strcspn(p, " ");
+
+        if (n < sizeof(master)) {
+            memcpy(master, p, n);
+            master[n] = '\0';
+        }
+
+        for (;;) {
+            p += strspn(p, " \t\n");
+
+            if (*p == '\0') {
+                break;
+            }
+
+            n = strcspn(p, " \t\n");
+
+            #define IS(word) (n == strlen(word) && memcmp(p, word, n) == 0)
+
+            if      (IS("autogen"))     { useAutogen   = 1; useGmake = 1; }
+            else if (IS("autotools"))   { useAutotools = 1; useGmake = 1; }
+            else if (IS("configure"))   { useConfigure = 1; useGmake = 1; }
+            else if (IS("cmake+gmake")) { useCmake     = 1; useGmake = 1; }
+            else if (IS("cmake+ninja")) { useCmake     = 1; useNinja = 1; }
+            else if (IS("cmake"))       { useCmake     = 1; useNinja = 1; }
+            else if (IS("xmake"))       { useXmake     = 1; }
+            else if (IS("meson"))       { useMeson     = 1; useNinja = 1; }
+            else if (IS("ninja"))       { useNinja     = 1; }
+            else if (IS("gmake"))       { useGmake     = 1; }
+            else if (IS("rake"))        { useRake      = 1; }
+            else if (IS("cargo"))       { useCargo     = 1; }
+            else if (IS("cabal"))       { useCabal     = 1; }
+            else if (IS("go"))          { useGo        = 1; }
+            else if (IS("waf"))         { useWaf       = 1; }
+
+            #undef IS
+
+            p += n;
+        }
+    }
+
+    if (is_empty(install)) {
+        const char * s = NULL;
+
+        if      (strcmp(master, "autogen")   == 0) s = "configure";
+        else if (strcmp(master, "autotools") == 0) s = "configure";
+        else if (strcmp(master, "configure") == 0) s = "configure";
+        else if (strncmp(master, "cmake", 5) == 0) s = "cmakew";
+        else if (strcmp(master, "xmake")     == 0) s = "xmakew";
+        else if (strcmp(master, "meson")     == 0) s = "mesonw";
+        else if (strcmp(master, "ninja")     == 0) s = "ninjaw clean && ninjaw && ninjaw install";
+        else if (strcmp(master, "gmake")     == 0) s = "gmakew clean && gmakew && gmakew install";
+        else if (strcmp(master, "cargo")     == 0) s = "cargow install";
+        else if (strcmp(master, "cabal")     == 0) s = "cabal_v2_install";
+        else if (strcmp(master, "go")        == 0) s = "gow";
+        else if (strcmp(master, "waf")       == 0) s = "waf";
+
+        if (s != NULL && set(install, s, strlen(s)) != 0) return -1;
+    }
+
+    // in the same order as ppkg appends them
+    const struct { int cond; const char * words; } upps[] = {
+        { !is_empty(fixUrl) || !is_empty(patches), "patch" },
+        { !is_empty(depPym), "python3" },
+        { !is_empty(depPlm), "perl gmake" },
+        { useAutogen,   "gmake gm4 perl autoconf automake" },
+        { useAutotools, "gmake gm4 perl autoconf automake" },
+        { useConfigure, "gmake" },
+        { useMeson,     "python3" },
+        { useCmake,     "cmake" },
+        { useGmake,     "gmake" },
+        { useXmake,     "xmake" },
+        { useNinja,     "ninja" },
+        { useCabal,     "cabal-install" },
+        { useRake,      "ruby" },
+        { useGo,        "golang" },
+        { useWaf,       "python3" },
+    };
+
+    for (size_t i = 0; i < sizeof(upps) / sizeof(upps[0]); i++) {
+        if (upps[i].cond && append_word(depUpp, upps[i].words) != 0) return -1;
+    }
+
+    if (useMeson && append_word(depPym, "meson") != 0) return -1;
+
+    if (useWaf || useGo || useCargo || useXmake || useCabal) {
+        if (set(binbstd, "1", 1) != 0) return -1;
+    } else if (is_empty(binbstd)) {
+        if (set(binbstd, strcmp(master, "gmake") == 0 ? "1" : "0", 1) != 0) return -1;
+    }
+
+    ///////////////////////////////////////////////////////////
+
+    if (is_empty(webUrl)) {
+        if (gitUrl->isSet) {
+            if (set(webUrl, gitUrl->value.p, gitUrl->value.length) != 0) return -1;
+        }
+    }
+
+    if (is_empty(parallel)) {
+        if (set(parallel, "1", 1) != 0) return -1;
+    }
+
+    if (is_empty(unity) || strcmp(unity->value.p, "true") == 0) {
+        if (set(unity, "1", 1) != 0) return -1;
+    } else if (strcmp(unity->value.p, "false") == 0) {
+        if (set(unity, "0", 1) != 0) return -1;
+    }
+
+    return 0;
+}
+
+static void print_json_string(const char * s, size_t n) {
+    putchar('"');
+
+    for (size_t i = 0; i < n; i++) {
+        const unsigned char c = s[i];
+
+        switch (c) {
+            case '"':  fputs("\\\"", stdout); break;
+            case '\\': fputs("\\\\", stdout); break;
+            case '\b': fputs("\\b", stdout); break;
+            case '\f': fputs("\\f", stdout); break;
+            case '\n': fputs("\\n", stdout); break;
+            case '\r': fputs("\\r", stdout); break;
+            case '\t': fputs("\\t", stdout); break;
+            default:
+                if (c < 0x20) {
+                    printf("\\u%04x", c);
+                } else {
+                    putchar(c);
+                }
+        }
+    }
+
+    putchar('"');
+}
+
+static int is_yaml_plain_safe(const char * s, size_t n) {
+    if (n == 0 || strchr("-?:,[]{}#&*!|>'\"%@` ", s[0]) != NULL || s[n - 1] == ' ' || s[n - 1] == ':') {
+        return 0;
+    }
+
+    if ((n == 1 && s[0] == '~') || (n == 4 && (strncmp(s, "null", 4) == 0 || strncmp(s, "Null", 4) == 0 || strncmp(s, "NULL", 4) == 0))) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if ((unsigned char)s[i] < 0x20 || s[i] == 0x7f) {
+            return 0;
+        }
+
+        if (i + 1 < n && ((s[i] == ':' && s[i + 1] == ' ') || (s[i] == ' ' && s[i + 1] == '#'))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void print_yaml_mapping(const char * key, const char * s, size_t n) {
+    printf("%s: ", key);
+
+    if (is_yaml_plain_safe(s, n)) {
+        fwrite(s, 1, n, stdout);
+        putchar('\n');
+        return;
+    }
+
+    if (memchr(s, '\n', n) == NULL) {
+        putchar('\'');
+
+        for (size_t i = 0; i < n; i++) {
+            if (s[i] == '\'') {
+                putchar('\'');
+            }
+
+            putchar(s[i]);
+        }
+
+        fputs("'\n", stdout);
+        return;
+    }
+
+    // the indentation indicator is needed if the first line starts with spaces
+    fputs(s[0] == ' ' ? "|2-\n" : "|-\n", stdout);
+
+    const char * p = s;
+    const char * end = s + n;
+
+    while (p <= end) {
+        const char * q = memchr(p, '\n', end - p);
+
+        if (q == NULL) {
+            q = end;
+        }
+
+        if (q > p) {
+            fputs("  ", stdout);
+            fwrite(p, 1, q - p, stdout);
+        }
+
+        putchar('\n');
+
+        p = q + 1;
+    }
+}
+
+// run <FALLBACK> info-available <PKGNAME> --json|--yaml in place of a formula which this program can not parse
+static int fallback(const char * executable, const char * pkgname, const char * format) {
+    fflush(stdout);
+
+    pid_t pid = fork();
+
+    if (pid == -1) {
+        perror(NULL);
+        return -1;
+    }
+
+    if (pid == 0) {
+        execl(executable, executable, "info-available", pkgname, format, NULL);
+        perror(executable);
+        _exit(127);
+    }
+
+    int status;
+
+    if (waitpid(pid, &status, 0) == -1) {
+        perror(NULL);
+        return -1;
+    }
+
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : UNSUPPORTED;
+}
+
+static int stream(int argc, const char * argv[]) {
+    const int json = strcmp(argv[1], "--json") == 0;
+
+    const char * fieldsArg = NULL;
+    const char * installedRoot = NULL;
+    const char * fallbackExecutable = NULL;
+
+    for (int i = 2; i < argc; i++) {
+        if (strncmp(argv[i], "--fields=", 9) == 0) {
+            fieldsArg = argv[i] + 9;
+        } else if (strncmp(argv[i], "--installed-root=", 17) == 0) {
+            installedRoot = argv[i] + 17;
+        } else if (strncmp(argv[i], "--fallback=", 11) == 0) {
+            fallbackExecutable = argv[i] + 11;
+        } else {
+            fprintf(stderr, "unrecognized argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////
+
+    // the output keys, either the default ones or the ones given by --fields=
+    const char ** keys = NULL;
+
+    size_t keyCount = 0;
+
+    char * fieldsCopy = NULL;
+
+    if (fieldsArg == NULL) {
+        const char * const * defaultKeys = json ? JSON_KEYS : YAML_KEYS;
+
+        while (defaultKeys[keyCount] != NULL) {
+            keyCount++;
+        }
+
+        keys = (const char **)defaultKeys;
+    } else {
+        fieldsCopy = copy_string(fieldsArg, strlen(fieldsArg));
+
+        if (fieldsCopy == NULL) {
+            return 5;
+        }
+
+        keys = calloc(strlen(fieldsCopy) / 2 + 1, sizeof(char *));
+
+        if (keys == NULL) {
+            perror(NULL);
+            free(fieldsCopy);
+            return 5;
+        }
+
+        for (char * p = strtok(fieldsCopy, ","); p != NULL; p = strtok(NULL, ",")) {
+            keys[keyCount++] = p;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////
+
+    // the formula keys to be loaded, the ones needed by derive() come first
+    size_t fieldCount = 0;
+
+    Field * fields = calloc(sizeof(JSON_KEYS) / sizeof(JSON_KEYS[0]) + keyCount, sizeof(Field));
+
+    if (fields == NULL) {
+        perror(NULL);
+        return 5;
+    }
+
+    for (size_t i = 0; JSON_KEYS[i] != NULL; i++) {
+        if (strcmp(JSON_KEYS[i], "pkgname") != 0) {
+            fields[fieldCount].key = JSON_KEYS[i];
+            fields[fieldCount].name = JSON_KEYS[i];
+            fieldCount++;
+        }
+    }
+
+    for (size_t i = 0; i < keyCount; i++) {
+        if (strcmp(keys[i], "pkgname") != 0 && strcmp(keys[i], "installed") != 0 && get(fields, fieldCount, keys[i]) == NULL) {
+            fields[fieldCount].key = keys[i];
+            fields[fieldCount].name = keys[i];
+            fieldCount++;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////
+
+    int ret = 0;
+
+    size_t count = 0;
+
+    Buffer line = {0};
+
+    Buffer installedPath = {0};
+
+    if (json) {
+        fputs("[\n", stdout);
+    }
+
+    for (;;) {
+        int r = read_line(stdin, &line);
+
+        if (r == 1) {
+            break;
+        }
+
+        if (r == -1) {
+            ret = 7;
+            break;
+        }
+
+        char * tab = strchr(line.p, '\t');
+
+        if (tab == NULL) {
+            continue;
+        }
+
+        *tab = '\0';
+
+        const char * pkgname = line.p;
+        const char * formulaFilePath = tab + 1;
+
+        ///////////////////////////////////////////////////////
+
+        char * content = NULL;
+        size_t contentLength = 0;
+
+        r = read_file(formulaFilePath, &content, &contentLength);
+
+        if (r == 0) {
+            r = load(formulaFilePath, content, contentLength, fields, fieldCount);
+            free(content);
+        }
+
+        if (r == 0) {
+            r = derive(pkgname, fields, fieldCount);
+        }
+
+        if (r == -1) {
+            ret = 7;
+            break;
+        }
+
+        if (r != 0 && fallbackExecutable == NULL) {
+            fprintf(stderr, "%s: %s can not be loaded.\n", pkgname, formulaFilePath);
+            ret = UNSUPPORTED;
+            continue;
+        }
+
+        if (count++ > 0) {
+            fputs(json ? ",\n" : "---\n", stdout);
+        }
+
+        if (r != 0) {
+            if (fallback(fallbackExecutable, pkgname, json ? "--json" : "--yaml") != 0) {
+                fprintf(stderr, "%s: %s can not be loaded.\n", pkgname, formulaFilePath);
+                ret = UNSUPPORTED;
+
+                // keep the JSON array well-formed
+                if (json) {
+                    fputs("{}\n", stdout);
+                }
+            }
+
+            continue;
+        }
+
+        ///////////////////////////////////////////////////////
+
+        if (json) {
+            fputs("{", stdout);
+        }
+
+        int isFirst = 1;
+
+        for (size_t i = 0; i < keyCount; i++) {
+            const char * value;
+            size_t       valueLength;
+
+            if (strcmp(keys[i], "pkgname") == 0) {
+                value = pkgname;
+                valueLength = strlen(pkgname);
+            } else if (strcmp(keys[i], "installed") == 0) {
+                if (installedRoot == NULL) {
+                    continue;
+                }
+
+                installedPath.length = 0;
+
+                if (buffer_append(&installedPath, installedRoot, strlen(installedRoot)) != 0 ||
+                    buffer_append(&installedPath, "/", 1) != 0 ||
+                    buffer_append(&installedPath, pkgname, strlen(pkgname)) != 0 ||
+                    buffer_append(&installedPath, "/.ppkg/RECEIPT.yml", 18) != 0) {
+                    ret = 7;
+                    break;
+                }
+
+                value = access(installedPath.p, F_OK) == 0 ? "yes" : "no";
+                valueLength = strlen(value);
+            } else {
+                const Field * field = get(fields, fieldCount, keys[i]);
+
+                if (field == NULL || !field->isSet || field->value.length == 0) {
+                    continue;
+                }
+
+                value = field->value.p;
+                valueLength = field->value.length;
+            }
+
+            if (json) {
+                fputs(isFirst ? "\n  " : ",\n  ", stdout);
+                print_json_string(keys[i], strlen(keys[i]));
+                fputs(": ", stdout);
+                print_json_string(value, valueLength);
+            } else {
+                print_yaml_mapping(keys[i], value, valueLength);
+            }
+
+            isFirst = 0;
+        }
+
+        if (json) {
+            fputs(isFirst ? "}\n" : "\n}\n", stdout);
+        }
+    }
+
+    if (json) {
+        fputs("]\n", stdout);
+    }
+
+    for (size_t i = 0; i < fieldCount; i++) {
+        free(fields[i].value.p);
+    }
+
+    free(fields);
+    free(line.p);
+    free(installedPath.p);
+
+    if (fieldsCopy != NULL) {
+        free(keys);
+        free(fieldsCopy);
+    }
+
+    return ret;
+}
+
+int main(int argc, const char *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <FORMULA-FILEPATH> [<KEY>=<VARIABLE-NAME>]...\n", argv[0]);
+        printf("Usage: %s --json|--yaml [--fields=<KEY>,...] [--installed-root=<DIR>] [--fallback=<PPKG>] < <PKGNAME-FORMULA-FILEPATH-LIST>\n", argv[0]);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "--json") == 0 || strcmp(argv[1], "--yaml") == 0) {
+        return stream(argc, argv);
+    }
+
+    if (argv[1][0] == '\0') {
+        printf("Usage: %s <FORMULA-FILEPATH> [<KEY>=<VARIABLE-NAME>]..., <FORMULA-FILEPATH> is unspecified.\n", argv[0]);
+        return 2;
+    }
+
+    ///////////////////////////////////////////////////////////
+
+    Field * fields = calloc(argc, sizeof(Field));
+
+    if (fields == NULL) {
+        perror(NULL);
+        return 5;
+    }
+
+    size_t fieldCount = 0;
+
+    for (int i = 2; i < argc; i++) {
+        const char * p = strchr(argv[i], '=');
+
+        if (p == NULL) {
+            fprintf(stderr, "not a <KEY>=<VARIABLE-NAME> pair: %s\n", argv[i]);
+            free(fields);
+            return 2;
+        }
+
+        // the key part is compared by lookup() up to its '\0'
+        char * key = copy_string(argv[i], p - argv[i]);
+
+        if (key == NULL) {
+            free(fields);
+            return 5;
+        }
+
+        fields[fieldCount].key = key;
+        fields[fieldCount].name = p + 1;
+        fieldCount++;
+    }
+
+    ///////////////////////////////////////////////////////////
+
+    char * content = NULL;
+    size_t contentLength = 0;
+
+    int ret = read_file(argv[1], &content, &contentLength);
+
+    if (ret == 0) {
+        ret = load(argv[1], content, contentLength, fields, fieldCount);
+
+        free(content);
+
+        if (ret == 0) {
+            for (size_t i = 0; i < fieldCount; i++) {
+                if (fields[i].isSet) {
+                    print_assignment(&fields[i]);
+                }
+            }
+        } else if (ret == -1) {
+            ret = 7;
+        }
+    }
+
+    for (size_t i = 0; i < fieldCount; i++) {
+        free((char *)fields[i].key);
+        free(fields[i].value.p);
+    }
+
+    free(fields);
+
+    return ret;
+}
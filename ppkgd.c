@@ -0,0 +1,1228 @@
+// readlink() is not declared with -std=c99 otherwise
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <poll.h>
+
+// ppkgd keeps the formula index and the installed-package database of a ppkg home in memory and answers read-only queries over a unix socket.
+//
+// ppkgd serve --socket=<PATH> --home=<PPKG_HOME> --platform=<TARGET-PLATFORM-NAME> --default-target=<TARGET-PLATFORM-SPEC>
+// ppkgd query --socket=<PATH> -- <PPKG-ARGUMENTS>...
+//
+// a request is the ppkg arguments separated by NUL, the response is the exit status on the first line followed by what ppkg would print.
+// whatever ppkgd is not sure to answer exactly as ppkg does is replied with exit status 100, then the caller is supposed to run ppkg as usual.
+//
+// nothing is cached blindly: the formula index and the database files are re-read when their stat changes, and the formula index is
+// only trusted if neither the formula directories nor the formula file of the queried package are newer than it, which is what
+// ppkg __formula_index_is_fresh checks as well. stat is used rather than inotify because ppkg runs on macOS and BSDs too.
+
+#define FALLBACK 100
+
+#define MAX_REQUEST_SIZE 65536
+
+// requests are served one at a time, so a client which does not finish sending its request within this time is replied with FALLBACK
+#define REQUEST_TIMEOUT_MILLISECONDS 2000
+
+// a client which is not answered within this time, because the daemon is stuck or busy with the others, gives up with FALLBACK
+// and lets ppkg answer the query itself
+#define QUERY_TIMEOUT_MILLISECONDS 3000
+
+typedef struct {
+    char * p;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static int buffer_append(Buffer * b, const char * s, size_t n) {
+    if (b->length + n + 1 > b->capacity) {
+        size_t capacity = b->capacity == 0 ? 256 : b->capacity;
+
+        while (b->length + n + 1 > capacity) {
+            capacity <<= 1;
+        }
+
+        char * p = realloc(b->p, capacity);
+
+        if (p == NULL) {
+            perror(NULL);
+            return -1;
+        }
+
+        b->p = p;
+        b->capacity = capacity;
+    }
+
+    memcpy(b->p + b->length, s, n);
+    b->length += n;
+    b->p[b->length] = '\0';
+    return 0;
+}
+
+static int buffer_append_string(Buffer * b, const char * s) {
+    return buffer_append(b, s, strlen(s));
+}
+
+static char * copy_string(const char * s, size_t n) {
+    char * p = malloc(n + 1);
+
+    if (p == NULL) {
+        perror(NULL);
+        return NULL;
+    }
+
+    memcpy(p, s, n);
+    p[n] = '\0';
+    return p;
+}
+
+static int same_stat(const struct stat * a, const struct stat * b) {
+    return a->st_ino == b->st_ino && a->st_dev == b->st_dev && a->st_size == b->st_size && a->st_mtime == b->st_mtime;
+}
+
+// read the whole file, returns NULL if it does not exist or can not be read
+static char * read_file(const char * filepath, size_t * contentLength) {
+    int fd = open(filepath, O_RDONLY);
+
+    if (fd == -1) {
+        return NULL;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    char * p = malloc(st.st_size + 1);
+
+    if (p == NULL) {
+        perror(NULL);
+        close(fd);
+        return NULL;
+    }
+
+    size_t n = 0;
+
+    while (n < (size_t)st.st_size) {
+        ssize_t readBytes = read(fd, p + n, st.st_size - n);
+
+        if (readBytes <= 0) {
+            break;
+        }
+
+        n += readBytes;
+    }
+
+    close(fd);
+
+    p[n] = '\0';
+
+    *contentLength = n;
+
+    return p;
+}
+
+///////////////////////////////////////////////////////////////
+
+static const char * home;
+static const char * platform;
+static const char * defaultTarget;
+
+///////////////////////////////////////////////////////////////
+
+// <PACKAGE-NAME> <REPO-NAME> <FORMULA-FILEPATH> <FORMULA-SHA256> <PKGTYPE> <VERSION> <DEP-PKG> <SUMMARY>
+#define FORMULA_INDEX_COLUMNS 8
+
+typedef struct {
+    char * fields[FORMULA_INDEX_COLUMNS];
+} Row;
+
+static struct {
+    char * content;
+    Row * rows;
+    size_t rowCount;
+    struct stat st;
+    int loaded;
+
+    // repos.d, repos.d/<REPO>/formula and repos.d/<REPO>/formula/<PLATFORM>
+    char ** dirs;
+    size_t dirCount;
+} formulaIndex;
+
+static void formula_index_free(void) {
+    free(formulaIndex.content);
+    free(formulaIndex.rows);
+
+    for (size_t i = 0; i < formulaIndex.dirCount; i++) {
+        free(formulaIndex.dirs[i]);
+    }
+
+    free(formulaIndex.dirs);
+
+    memset(&formulaIndex, 0, sizeof(formulaIndex));
+}
+
+static int formula_index_add_dir(const char * dir) {
+    char ** dirs = realloc(formulaIndex.dirs, (formulaIndex.dirCount + 1) * sizeof(char *));
+
+    if (dirs == NULL) {
+        perror(NULL);
+        return -1;
+    }
+
+    formulaIndex.dirs = dirs;
+
+    char * p = copy_string(dir, strlen(dir));
+
+    if (p == NULL) {
+        return -1;
+    }
+
+    formulaIndex.dirs[formulaIndex.dirCount++] = p;
+    return 0;
+}
+
+// the formula directories are collected from the rows, a repository without any formula of this platform can not shadow anything
+static int formula_index_collect_dirs(void) {
+    Buffer b = {0};
+
+    if (buffer_append_string(&b, home) != 0 || buffer_append_string(&b, "/repos.d") != 0 || formula_index_add_dir(b.p) != 0) {
+        free(b.p);
+        return -1;
+    }
+
+    for (size_t i = 0; i < formulaIndex.rowCount; i++) {
+        const char * filepath = formulaIndex.rows[i].fields[2];
+        const char * slash = strrchr(filepath, '/');
+
+        if (slash == NULL) {
+            continue;
+        }
+
+        b.length = 0;
+
+        if (buffer_append(&b, filepath, slash - filepath) != 0) {
+            free(b.p);
+            return -1;
+        }
+
+        int found = 0;
+
+        for (size_t j = 0; j < formulaIndex.dirCount; j++) {
+            if (strcmp(formulaIndex.dirs[j], b.p) == 0) {
+                found = 1;
+                break;
+            }
+        }
+
+        if (!found && formula_index_add_dir(b.p) != 0) {
+            free(b.p);
+            return -1;
+        }
+    }
+
+    free(b.p);
+    return 0;
+}
+
+// returns 0 if the formula index is loaded and up to date with its file
+static int formula_index_load(void) {
+    Buffer filepath = {0};
+
+    if (buffer_append_string(&filepath, home) != 0 || buffer_append_string(&filepath, "/index.d/") != 0 || buffer_append_string(&filepath, platform) != 0 || buffer_append_string(&filepath, ".tsv") != 0) {
+        free(filepath.p);
+        return -1;
+    }
+
+    struct stat st;
+
+    if (stat(filepath.p, &st) == -1) {
+        free(filepath.p);
+        formula_index_free();
+        return -1;
+    }
+
+    if (formulaIndex.loaded && same_stat(&formulaIndex.st, &st)) {
+        free(filepath.p);
+        return 0;
+    }
+
+    formula_index_free();
+
+    size_t contentLength = 0;
+
+    char * content = read_file(filepath.p, &contentLength);
+
+    free(filepath.p);
+
+    if (content == NULL) {
+        return -1;
+    }
+
+    size_t lineCount = 0;
+
+    for (size_t i = 0; i < contentLength; i++) {
+        if (content[i] == '\n') {
+            lineCount++;
+        }
+    }
+
+    Row * rows = calloc(lineCount + 1, sizeof(Row));
+
+    if (rows == NULL) {
+        perror(NULL);
+        free(content);
+        return -1;
+    }
+
+    size_t rowCount = 0;
+
+    char * p = content;
+
+    while (*p != '\0') {
+        char * end = strchr(p, '\n');
+
+        if (end == NULL) {
+            end = p + strlen(p);
+        } else {
+            *end++ = '\0';
+        }
+
+        Row * row = &rows[rowCount];
+
+        size_t column = 0;
+
+        row->fields[column++] = p;
+
+        for (char * q = p; *q != '\0'; q++) {
+            if (*q == '\t') {
+                *q = '\0';
+
+                if (column < FORMULA_INDEX_COLUMNS) {
+                    row->fields[column++] = q + 1;
+                }
+            }
+        }
+
+        if (column == FORMULA_INDEX_COLUMNS) {
+            rowCount++;
+        }
+
+        p = end;
+    }
+
+    formulaIndex.content = content;
+    formulaIndex.rows = rows;
+    formulaIndex.rowCount = rowCount;
+    formulaIndex.st = st;
+    formulaIndex.loaded = 1;
+
+    if (formula_index_collect_dirs() != 0) {
+        formula_index_free();
+        return -1;
+    }
+
+    return 0;
+}
+
+// the rows are sorted by <PACKAGE-NAME> with sort -t '\t' -k1,1, which is not necessarily the byte order, so do not bisect
+static const Row * formula_index_find(const char * pkgname) {
+    for (size_t i = 0; i < formulaIndex.rowCount; i++) {
+        if (strcmp(formulaIndex.rows[i].fields[0], pkgname) == 0) {
+            return &formulaIndex.rows[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int is_newer_than_formula_index(const char * path) {
+    struct stat st;
+    return stat(path, &st) == 0 && st.st_mtime > formulaIndex.st.st_mtime;
+}
+
+// returns 1 if the formula index can be trusted for the given package
+static int formula_index_is_fresh_for(const char * pkgname, const Row ** row) {
+    if (formula_index_load() != 0) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < formulaIndex.dirCount; i++) {
+        if (is_newer_than_formula_index(formulaIndex.dirs[i])) {
+            return 0;
+        }
+    }
+
+    *row = formula_index_find(pkgname);
+
+    if (*row != NULL && is_newer_than_formula_index((*row)->fields[2])) {
+        return 0;
+    }
+
+    return 1;
+}
+
+///////////////////////////////////////////////////////////////
+
+// .db/receipt.d/<INSTALL-SHA>.sh files never change once written, a new install gets a new <INSTALL-SHA>
+typedef struct Receipt {
+    char * sha;
+    char * content;
+    struct Receipt * next;
+} Receipt;
+
+static Receipt * receipts;
+
+static const char * receipt_load(const char * sha) {
+    for (Receipt * r = receipts; r != NULL; r = r->next) {
+        if (strcmp(r->sha, sha) == 0) {
+            return r->content;
+        }
+    }
+
+    Buffer filepath = {0};
+
+    if (buffer_append_string(&filepath, home) != 0 || buffer_append_string(&filepath, "/installed/.db/receipt.d/") != 0 || buffer_append_string(&filepath, sha) != 0 || buffer_append_string(&filepath, ".sh") != 0) {
+        free(filepath.p);
+        return NULL;
+    }
+
+    size_t contentLength = 0;
+
+    char * content = read_file(filepath.p, &contentLength);
+
+    free(filepath.p);
+
+    if (content == NULL) {
+        return NULL;
+    }
+
+    Receipt * r = calloc(1, sizeof(Receipt));
+
+    if (r == NULL) {
+        perror(NULL);
+        free(content);
+        return NULL;
+    }
+
+    r->sha = copy_string(sha, strlen(sha));
+
+    if (r->sha == NULL) {
+        free(content);
+        free(r);
+        return NULL;
+    }
+
+    r->content = content;
+    r->next = receipts;
+    receipts = r;
+
+    return content;
+}
+
+// a receipt is made of NAME='VALUE' lines where ' in VALUE is written as '\'', VALUE may span lines.
+// returns 1 and fills value if NAME is found, 0 if not found, -1 on error
+static int receipt_get(const char * content, const char * name, Buffer * value) {
+    size_t nameLength = strlen(name);
+
+    const char * p = content;
+
+    while (*p != '\0') {
+        const char * q = p;
+
+        while (*q != '=' && *q != '\n' && *q != '\0') {
+            q++;
+        }
+
+        if (*q != '=' || q[1] != '\'') {
+            return -1;
+        }
+
+        int found = (size_t)(q - p) == nameLength && strncmp(p, name, nameLength) == 0;
+
+        value->length = 0;
+
+        for (q += 2; ; q++) {
+            if (*q == '\0') {
+                return -1;
+            }
+
+            if (*q == '\'') {
+                if (strncmp(q, "'\\''", 4) == 0) {
+                    if (found && buffer_append(value, "'", 1) != 0) {
+                        return -1;
+                    }
+
+                    q += 3;
+                } else {
+                    break;
+                }
+            } else if (found && buffer_append(value, q, 1) != 0) {
+                return -1;
+            }
+        }
+
+        if (found) {
+            if (value->p == NULL && buffer_append(value, "", 0) != 0) {
+                return -1;
+            }
+
+            return 1;
+        }
+
+        // skip the closing ' and the '\n'
+        p = q + 1;
+
+        if (*p == '\n') {
+            p++;
+        }
+    }
+
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////
+
+// ^[A-Za-z0-9+-._@]{1,50}$
+static int is_valid_package_name(const char * s) {
+    size_t n = strlen(s);
+
+    if (n == 0 || n > 50) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        char c = s[i];
+
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            continue;
+        }
+
+        // the bracket expression [+-.] of grep -E is a range from + to .
+        if ((c >= '+' && c <= '.') || c == '_' || c == '@') {
+            continue;
+        }
+
+        return 0;
+    }
+
+    return 1;
+}
+
+// the target platform spec part of a package spec that inspect_package_spec would keep as is
+static int is_canonical_target(const char * s, size_t n) {
+    const char * dash1 = memchr(s, '-', n);
+
+    if (dash1 == NULL || dash1 == s) {
+        return 0;
+    }
+
+    const char * dash2 = memchr(dash1 + 1, '-', n - (dash1 + 1 - s));
+
+    if (dash2 == NULL || dash2 == dash1 + 1 || dash2 + 1 == s + n || memchr(dash2 + 1, '-', n - (dash2 + 1 - s)) != NULL) {
+        return 0;
+    }
+
+    size_t nameLength = dash1 - s;
+    size_t versLength = dash2 - dash1 - 1;
+    size_t archLength = s + n - dash2 - 1;
+
+    const char * vers = dash1 + 1;
+    const char * arch = dash2 + 1;
+
+#define IS(p, length, literal) ((length) == sizeof(literal) - 1 && strncmp(p, literal, length) == 0)
+
+    if (IS(s, nameLength, "linux")) {
+        return IS(vers, versLength, "glibc") || IS(vers, versLength, "musl");
+    }
+
+    if (IS(s, nameLength, "macos")) {
+        return IS(arch, archLength, "x86_64") || IS(arch, archLength, "arm64");
+    }
+
+    if (IS(s, nameLength, "freebsd") || IS(s, nameLength, "openbsd") || IS(s, nameLength, "netbsd")) {
+        return !IS(arch, archLength, "x86_64");
+    }
+
+    if (IS(s, nameLength, "dragonflybsd")) {
+        return !IS(arch, archLength, "amd64");
+    }
+
+#undef IS
+
+    return 0;
+}
+
+// expand a <PACKAGE-NAME> or check a <PACKAGE-SPEC> the way inspect_package_spec does, returns 0 if that can not be done exactly
+static int inspect_package_spec(const char * arg, Buffer * spec) {
+    spec->length = 0;
+
+    const char * slash = strrchr(arg, '/');
+
+    if (slash == NULL) {
+        return is_valid_package_name(arg) && buffer_append_string(spec, defaultTarget) == 0 && buffer_append(spec, "/", 1) == 0 && buffer_append_string(spec, arg) == 0;
+    }
+
+    return is_valid_package_name(slash + 1) && is_canonical_target(arg, slash - arg) && buffer_append_string(spec, arg) == 0;
+}
+
+///////////////////////////////////////////////////////////////
+
+// the same checks and the same exit status as is_package_installed
+static int is_package_installed(const char * spec, Buffer * dir) {
+    static const struct {
+        const char * suffix;
+        int isDir;
+        int status;
+    } checks[] = {
+        { "",                   1, 10 },
+        { "/.ppkg",             1, 11 },
+        { "/.ppkg/MANIFEST.txt", 0, 13 },
+        { "/.ppkg/RECEIPT.yml",  0, 14 },
+    };
+
+    Buffer path = {0};
+
+    dir->length = 0;
+
+    if (buffer_append_string(dir, home) != 0 || buffer_append_string(dir, "/installed/") != 0 || buffer_append_string(dir, spec) != 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+        path.length = 0;
+
+        if (buffer_append(&path, dir->p, dir->length) != 0 || buffer_append_string(&path, checks[i].suffix) != 0) {
+            free(path.p);
+            return -1;
+        }
+
+        struct stat st;
+
+        if (stat(path.p, &st) == -1 || (checks[i].isDir ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode))) {
+            free(path.p);
+            return checks[i].status;
+        }
+    }
+
+    free(path.p);
+    return 0;
+}
+
+// __load_receipt_of_the_given_package refuses a receipt that lacks these or was not made for <PACKAGE-SPEC>, leave the error message to it
+static int receipt_is_sane(const char * content, const char * spec) {
+    static const char * const requiredNames[] = {
+        "RECEIPT_PACKAGE_PKGNAME",
+        "RECEIPT_PACKAGE_PKGTYPE",
+        "RECEIPT_PACKAGE_VERSION",
+        "RECEIPT_PACKAGE_SUMMARY",
+        "RECEIPT_PACKAGE_WEB_URL",
+        "RECEIPT_PACKAGE_BUILTBY",
+        "RECEIPT_PACKAGE_BUILTAT",
+        "RECEIPT_PACKAGE_BUILTFOR",
+    };
+
+    const char * slash = strrchr(spec, '/');
+
+    Buffer value = {0};
+
+    int ret = 1;
+
+    for (size_t i = 0; ret && i < sizeof(requiredNames) / sizeof(requiredNames[0]); i++) {
+        if (receipt_get(content, requiredNames[i], &value) != 1 || value.length == 0) {
+            ret = 0;
+        } else if (i == 0) {
+            ret = strcmp(value.p, slash + 1) == 0;
+        } else if (i == 6) {
+            ret = value.length == 10;
+        } else if (i == 7) {
+            ret = value.length == (size_t)(slash - spec) && strncmp(value.p, spec, value.length) == 0;
+        }
+    }
+
+    free(value.p);
+
+    return ret;
+}
+
+// ppkg prints the receipt values with an unquoted echo, which splits words, expands globs and interprets backslashes
+static int print_like_unquoted_echo(const Buffer * value, Buffer * out) {
+    for (size_t i = 0; i < value->length; i++) {
+        switch (value->p[i]) {
+            case '\\':
+            case '*':
+            case '?':
+            case '[':
+                return FALLBACK;
+        }
+    }
+
+    // echo would take a leading -n or -e as its option
+    for (size_t i = 0; i < value->length; i++) {
+        char c = value->p[i];
+
+        if (c != ' ' && c != '\t' && c != '\n') {
+            if (c == '-') {
+                return FALLBACK;
+            }
+
+            break;
+        }
+    }
+
+    int pending = 0;
+
+    for (size_t i = 0; i < value->length; i++) {
+        char c = value->p[i];
+
+        if (c == ' ' || c == '\t' || c == '\n') {
+            pending = out->length > 0;
+            continue;
+        }
+
+        if (pending && buffer_append(out, " ", 1) != 0) {
+            return -1;
+        }
+
+        pending = 0;
+
+        if (buffer_append(out, &c, 1) != 0) {
+            return -1;
+        }
+    }
+
+    return buffer_append(out, "\n", 1);
+}
+
+///////////////////////////////////////////////////////////////
+
+// ppkg is-installed <PACKAGE-NAME|PACKAGE-SPEC>
+static int answer_is_installed(int argc, char * argv[], Buffer * out) {
+    (void)out;
+
+    if (argc != 2) {
+        return FALLBACK;
+    }
+
+    Buffer spec = {0};
+    Buffer dir = {0};
+
+    int ret = inspect_package_spec(argv[1], &spec) ? is_package_installed(spec.p, &dir) : FALLBACK;
+
+    free(spec.p);
+    free(dir.p);
+
+    return ret == -1 ? FALLBACK : ret;
+}
+
+// ppkg is-available <PACKAGE-NAME>
+static int answer_is_available(int argc, char * argv[], Buffer * out) {
+    (void)out;
+
+    if (argc != 2 || !is_valid_package_name(argv[1])) {
+        return FALLBACK;
+    }
+
+    const Row * row = NULL;
+
+    if (!formula_index_is_fresh_for(argv[1], &row)) {
+        return FALLBACK;
+    }
+
+    return row == NULL ? 1 : 0;
+}
+
+// ppkg info-available <PACKAGE-NAME> <pkgtype|version|summary|dep-pkg>
+static int answer_info_available(int argc, char * argv[], Buffer * out) {
+    if (argc != 3 || !is_valid_package_name(argv[1])) {
+        return FALLBACK;
+    }
+
+    int column;
+
+    if (strcmp(argv[2], "pkgtype") == 0) {
+        column = 4;
+    } else if (strcmp(argv[2], "version") == 0) {
+        column = 5;
+    } else if (strcmp(argv[2], "dep-pkg") == 0) {
+        column = 6;
+    } else if (strcmp(argv[2], "summary") == 0) {
+        column = 7;
+    } else {
+        return FALLBACK;
+    }
+
+    const Row * row = NULL;
+
+    if (!formula_index_is_fresh_for(argv[1], &row) || row == NULL) {
+        return FALLBACK;
+    }
+
+    // an empty version in the index means that it is derived at load time
+    if (column == 5 && row->fields[column][0] == '\0') {
+        return FALLBACK;
+    }
+
+    if (buffer_append_string(out, row->fields[column]) != 0 || buffer_append(out, "\n", 1) != 0) {
+        return FALLBACK;
+    }
+
+    return 0;
+}
+
+// ppkg info-installed <PACKAGE-NAME|PACKAGE-SPEC> <--prefix|KEY>
+static int answer_info_installed(int argc, char * argv[], Buffer * out) {
+    if (argc != 3) {
+        return FALLBACK;
+    }
+
+    const char * key = argv[2];
+
+    // these are not plain receipt values
+    if (key[0] == '\0' || strcmp(key, "--yaml") == 0 || strcmp(key, "--json") == 0 || strcmp(key, "--files") == 0 || strncmp(key, "builtat-", 8) == 0 || strncmp(key, "builtfor-", 9) == 0) {
+        return FALLBACK;
+    }
+
+    // only a plain identifier can name a receipt value
+    for (const char * p = key; *p != '\0'; p++) {
+        char c = *p;
+
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '+' || c == '-' || c == '.')) {
+            return FALLBACK;
+        }
+    }
+
+    Buffer spec = {0};
+    Buffer dir = {0};
+    Buffer name = {0};
+    Buffer value = {0};
+
+    int ret = FALLBACK;
+
+    if (!inspect_package_spec(argv[1], &spec) || is_package_installed(spec.p, &dir) != 0) {
+        goto finally;
+    }
+
+    if (strcmp(key, "--prefix") == 0) {
+        if (buffer_append(out, dir.p, dir.length) == 0 && buffer_append(out, "\n", 1) == 0) {
+            ret = 0;
+        }
+
+        goto finally;
+    }
+
+    // <PACKAGE-SPEC> is a symbolic link to the <INSTALL-SHA> directory
+    char target[1024];
+
+    ssize_t n = readlink(dir.p, target, sizeof(target) - 1);
+
+    if (n <= 0) {
+        goto finally;
+    }
+
+    target[n] = '\0';
+
+    const char * sha = strrchr(target, '/');
+
+    sha = sha == NULL ? target : sha + 1;
+
+    const char * content = receipt_load(sha);
+
+    if (content == NULL) {
+        goto finally;
+    }
+
+    if (!receipt_is_sane(content, spec.p)) {
+        goto finally;
+    }
+
+    if (buffer_append_string(&name, "RECEIPT_PACKAGE_") != 0) {
+        goto finally;
+    }
+
+    for (const char * p = key; *p != '\0'; p++) {
+        char c = *p;
+
+        if (c == '+' || c == '-' || c == '.') {
+            c = '_';
+        } else if (c >= 'a' && c <= 'z') {
+            c = c - 'a' + 'A';
+        }
+
+        if (buffer_append(&name, &c, 1) != 0) {
+            goto finally;
+        }
+    }
+
+    switch (receipt_get(content, name.p, &value)) {
+        case 1:
+            ret = print_like_unquoted_echo(&value, out);
+            ret = ret == -1 ? FALLBACK : ret;
+            break;
+        case 0:
+            ret = buffer_append(out, "\n", 1) == 0 ? 0 : FALLBACK;
+            break;
+    }
+
+finally:
+    free(spec.p);
+    free(dir.p);
+    free(name.p);
+    free(value.p);
+
+    return ret;
+}
+
+static int answer(int argc, char * argv[], Buffer * out) {
+    if (argc == 0) {
+        return FALLBACK;
+    }
+
+    if (strcmp(argv[0], "ping") == 0) {
+        return buffer_append_string(out, "pong\n") == 0 ? 0 : FALLBACK;
+    }
+
+    if (strcmp(argv[0], "is-installed") == 0) {
+        return answer_is_installed(argc, argv, out);
+    }
+
+    if (strcmp(argv[0], "is-available") == 0) {
+        return answer_is_available(argc, argv, out);
+    }
+
+    if (strcmp(argv[0], "info-available") == 0) {
+        return answer_info_available(argc, argv, out);
+    }
+
+    if (strcmp(argv[0], "info-installed") == 0) {
+        return answer_info_installed(argc, argv, out);
+    }
+
+    return FALLBACK;
+}
+
+///////////////////////////////////////////////////////////////
+
+static int write_all(int fd, const char * p, size_t n) {
+    while (n > 0) {
+        ssize_t writtenBytes = write(fd, p, n);
+
+        if (writtenBytes <= 0) {
+            return -1;
+        }
+
+        p += writtenBytes;
+        n -= writtenBytes;
+    }
+
+    return 0;
+}
+
+static void serve_one(int fd) {
+    Buffer request = {0};
+    Buffer out = {0};
+
+    char buf[4096];
+
+    int timedOut = 0;
+
+    struct timespec startedAt;
+
+    clock_gettime(CLOCK_MONOTONIC, &startedAt);
+
+    for (;;) {
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        long remaining = REQUEST_TIMEOUT_MILLISECONDS - ((now.tv_sec - startedAt.tv_sec) * 1000 + (now.tv_nsec - startedAt.tv_nsec) / 1000000);
+
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+        if (remaining <= 0 || poll(&pfd, 1, (int)remaining) <= 0) {
+            timedOut = 1;
+            break;
+        }
+
+        ssize_t readBytes = read(fd, buf, sizeof(buf));
+
+        if (readBytes < 0) {
+            timedOut = 1;
+            break;
+        }
+
+        if (readBytes == 0) {
+            break;
+        }
+
+        if (request.length + readBytes > MAX_REQUEST_SIZE || buffer_append(&request, buf, readBytes) != 0) {
+            free(request.p);
+            return;
+        }
+    }
+
+    // the arguments are separated by NUL, the last one is terminated by NUL too
+    char * argv[64];
+    int argc = 0;
+
+    for (size_t i = 0; i < request.length && argc < 64; ) {
+        argv[argc++] = request.p + i;
+        i += strlen(request.p + i) + 1;
+    }
+
+    int status = timedOut || request.length == 0 || argc == 64 ? FALLBACK : answer(argc, argv, &out);
+
+    if (status == FALLBACK) {
+        out.length = 0;
+    }
+
+    char head[16];
+
+    int headLength = snprintf(head, sizeof(head), "%d\n", status);
+
+    if (write_all(fd, head, headLength) == 0 && out.length > 0) {
+        write_all(fd, out.p, out.length);
+    }
+
+    free(request.p);
+    free(out.p);
+}
+
+static int make_address(const char * socketPath, struct sockaddr_un * address) {
+    if (strlen(socketPath) >= sizeof(address->sun_path)) {
+        fprintf(stderr, "socket path is too long: %s\n", socketPath);
+        return -1;
+    }
+
+    memset(address, 0, sizeof(struct sockaddr_un));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, socketPath);
+    return 0;
+}
+
+static int serve(const char * socketPath) {
+    struct sockaddr_un address;
+
+    if (make_address(socketPath, &address) != 0) {
+        return 2;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd == -1) {
+        perror("socket");
+        return 3;
+    }
+
+    // a socket file left behind by a ppkgd which did not exit normally
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0) {
+        fprintf(stderr, "ppkgd is already listening on %s\n", socketPath);
+        close(fd);
+        return 4;
+    }
+
+    close(fd);
+
+    unlink(socketPath);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd == -1) {
+        perror("socket");
+        return 3;
+    }
+
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) == -1) {
+        perror(socketPath);
+        close(fd);
+        return 5;
+    }
+
+    chmod(socketPath, 0600);
+
+    if (listen(fd, 64) == -1) {
+        perror(socketPath);
+        close(fd);
+        unlink(socketPath);
+        return 6;
+    }
+
+    // a client may go away before reading the response
+    signal(SIGPIPE, SIG_IGN);
+
+    for (;;) {
+        int clientFd = accept(fd, NULL, NULL);
+
+        if (clientFd == -1) {
+            continue;
+        }
+
+        // a client which does not read the response must not block the others either
+        struct timeval timeout = { .tv_sec = REQUEST_TIMEOUT_MILLISECONDS / 1000, .tv_usec = REQUEST_TIMEOUT_MILLISECONDS % 1000 * 1000 };
+
+        setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        serve_one(clientFd);
+
+        close(clientFd);
+    }
+}
+
+static int query(const char * socketPath, int argc, const char * argv[]) {
+    struct sockaddr_un address;
+
+    if (make_address(socketPath, &address) != 0) {
+        return FALLBACK;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd == -1) {
+        return FALLBACK;
+    }
+
+    struct timespec startedAt;
+
+    clock_gettime(CLOCK_MONOTONIC, &startedAt);
+
+    // connect blocks while the listen backlog is full, and the writes block while the daemon does not read, both are bounded by SO_SNDTIMEO
+    struct timeval timeout = { .tv_sec = QUERY_TIMEOUT_MILLISECONDS / 1000, .tv_usec = QUERY_TIMEOUT_MILLISECONDS % 1000 * 1000 };
+
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == -1) {
+        close(fd);
+        return FALLBACK;
+    }
+
+    for (int i = 0; i < argc; i++) {
+        if (write_all(fd, argv[i], strlen(argv[i]) + 1) != 0) {
+            close(fd);
+            return FALLBACK;
+        }
+    }
+
+    shutdown(fd, SHUT_WR);
+
+    Buffer response = {0};
+
+    char buf[4096];
+
+    for (;;) {
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        long remaining = QUERY_TIMEOUT_MILLISECONDS - ((now.tv_sec - startedAt.tv_sec) * 1000 + (now.tv_nsec - startedAt.tv_nsec) / 1000000);
+
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+        if (remaining <= 0 || poll(&pfd, 1, (int)remaining) <= 0) {
+            free(response.p);
+            close(fd);
+            return FALLBACK;
+        }
+
+        ssize_t readBytes = read(fd, buf, sizeof(buf));
+
+        if (readBytes < 0) {
+            free(response.p);
+            close(fd);
+            return FALLBACK;
+        }
+
+        if (readBytes == 0) {
+            break;
+        }
+
+        if (buffer_append(&response, buf, readBytes) != 0) {
+            free(response.p);
+            close(fd);
+            return FALLBACK;
+        }
+    }
+
+    close(fd);
+
+    char * newline = response.length == 0 ? NULL : memchr(response.p, '\n', response.length);
+
+    if (newline == NULL) {
+        free(response.p);
+        return FALLBACK;
+    }
+
+    int status = atoi(response.p);
+
+    size_t n = response.length - (newline + 1 - response.p);
+
+    if (n > 0) {
+        fwrite(newline + 1, 1, n, stdout);
+    }
+
+    free(response.p);
+
+    return status;
+}
+
+int main(int argc, const char *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s serve --socket=<PATH> --home=<PPKG_HOME> --platform=<TARGET-PLATFORM-NAME> --default-target=<TARGET-PLATFORM-SPEC>\n", argv[0]);
+        printf("Usage: %s query --socket=<PATH> -- <PPKG-ARGUMENTS>...\n", argv[0]);
+        return 1;
+    }
+
+    const char * socketPath = NULL;
+
+    int i;
+
+    for (i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            i++;
+            break;
+        } else if (strncmp(argv[i], "--socket=", 9) == 0) {
+            socketPath = argv[i] + 9;
+        } else if (strncmp(argv[i], "--home=", 7) == 0) {
+            home = argv[i] + 7;
+        } else if (strncmp(argv[i], "--platform=", 11) == 0) {
+            platform = argv[i] + 11;
+        } else if (strncmp(argv[i], "--default-target=", 17) == 0) {
+            defaultTarget = argv[i] + 17;
+        } else {
+            fprintf(stderr, "unrecognized argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    if (socketPath == NULL || socketPath[0] == '\0') {
+        fprintf(stderr, "--socket=<PATH> is unspecified.\n");
+        return 2;
+    }
+
+    if (strcmp(argv[1], "query") == 0) {
+        return query(socketPath, argc - i, argv + i);
+    }
+
+    if (strcmp(argv[1], "serve") == 0) {
+        if (home == NULL || home[0] == '\0' || platform == NULL || platform[0] == '\0' || defaultTarget == NULL || defaultTarget[0] == '\0') {
+            fprintf(stderr, "--home=<PPKG_HOME> --platform=<TARGET-PLATFORM-NAME> --default-target=<TARGET-PLATFORM-SPEC> all are required.\n");
+            return 2;
+        }
+
+        return serve(socketPath);
+    }
+
+    fprintf(stderr, "unrecognized action: %s\n", argv[1]);
+    return 2;
+}
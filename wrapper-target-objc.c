@@ -98,7 +98,61 @@ int main(int argc, char * argv[]) {
 
     /////////////////////////////////////////////////////////////////
 
-    char* argv2[argc + baseArgc + 5];
+    // PROXIED_LD_ARGS are only passed to the compiler driver when it is going to run the linker.
+
+    int ldArgc = 0;
+
+    char * const ldArgs = (action == ACTION_PREPROCESS || action == ACTION_COMPILE || action == ACTION_ASSEMBLE) ? NULL : getenv("PROXIED_LD_ARGS");
+
+    if (ldArgs != NULL && ldArgs[0] != '\0') {
+        ldArgc = 1;
+
+        for (int i = 0; ; i++) {
+            if (ldArgs[i] == '\0') {
+                break;
+            }
+
+            if (ldArgs[i] == ' ') {
+                ldArgc++;
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////
+
+    // PROXIED_MALLOC_ARGS are only passed to the compiler driver when it is going to create an executable.
+
+    int mallocArgc = 0;
+
+    char * mallocArgs = NULL;
+
+    if (action == ACTION_CREATE_STATICALLY_LINKED_EXECUTABLE) {
+        mallocArgs = getenv("PROXIED_MALLOC_ARGS");
+    } else if (action == 0) {
+        const char * msle = getenv("PACKAGE_CREATE_MOSTLY_STATICALLY_LINKED_EXECUTABLE");
+
+        if (msle != NULL && strcmp(msle, "1") == 0) {
+            mallocArgs = getenv("PROXIED_MALLOC_ARGS");
+        }
+    }
+
+    if (mallocArgs != NULL && mallocArgs[0] != '\0') {
+        mallocArgc = 1;
+
+        for (int i = 0; ; i++) {
+            if (mallocArgs[i] == '\0') {
+                break;
+            }
+
+            if (mallocArgs[i] == ' ') {
+                mallocArgc++;
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////
+
+    char* argv2[argc + baseArgc + ldArgc + mallocArgc + 5];
 
     if (action == ACTION_PREPROCESS || action == ACTION_COMPILE || action == ACTION_ASSEMBLE) {
         for (int i = 1; i < argc; i++) {
@@ -320,6 +374,59 @@ int main(int argc, char * argv[]) {
 
     /////////////////////////////////////////////////////////////////
 
+    if (ldArgc != 0) {
+        char * p = ldArgs;
+
+        for (int i = 0; ; i++) {
+            if (ldArgs[i] == '\0') {
+                if (p[0] != '\0') {
+                    argv2[argc++] = p;
+                }
+                break;
+            }
+
+            if (ldArgs[i] == ' ') {
+                ldArgs[i] = '\0';
+
+                if (p[0] != '\0') {
+                    argv2[argc++] = p;
+                }
+
+                p = &ldArgs[i + 1];
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////
+
+    // the allocator archive is wrapped by --whole-archive, so its malloc/free are always linked in
+    // and take precedence over the ones in libc which is linked after all the given arguments.
+
+    if (mallocArgc != 0) {
+        char * p = mallocArgs;
+
+        for (int i = 0; ; i++) {
+            if (mallocArgs[i] == '\0') {
+                if (p[0] != '\0') {
+                    argv2[argc++] = p;
+                }
+                break;
+            }
+
+            if (mallocArgs[i] == ' ') {
+                mallocArgs[i] = '\0';
+
+                if (p[0] != '\0') {
+                    argv2[argc++] = p;
+                }
+
+                p = &mallocArgs[i + 1];
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////
+
     if (action == ACTION_ASSEMBLE || action == ACTION_CREATE_SHARED_LIBRARY) {
         argv2[argc++] = (char*)"-fPIC";
     }
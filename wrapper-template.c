@@ -9,6 +9,65 @@
 #include <limits.h>
 #endif
 
+#if defined (__x86_64__)
+#include <cpuid.h>
+
+// https://gitlab.com/x86-psABIs/x86-64-ABI
+// returns the highest x86-64 micro-architecture level that the running cpu supports, one of 1, 2, 3, 4
+static int x86_64_level() {
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+        return 1;
+    }
+
+    unsigned int ecx81 = 0U;
+
+    {
+        unsigned int a, b, d;
+
+        if (__get_cpuid(0x80000001, &a, &b, &ecx81, &d) == 0) {
+            return 1;
+        }
+    }
+
+    // SSE3 SSSE3 CMPXCHG16B SSE4_1 SSE4_2 POPCNT LAHF-SAHF
+    if ((ecx & 0x00982201U) != 0x00982201U || (ecx81 & 0x1U) == 0U) {
+        return 1;
+    }
+
+    // FMA MOVBE OSXSAVE AVX F16C LZCNT
+    if ((ecx & 0x38401000U) != 0x38401000U || (ecx81 & 0x20U) == 0U) {
+        return 2;
+    }
+
+    unsigned int xcr0, xcr0hi;
+
+    __asm__ ("xgetbv" : "=a" (xcr0), "=d" (xcr0hi) : "c" (0));
+
+    // XMM YMM state are enabled by the operating system
+    if ((xcr0 & 0x6U) != 0x6U) {
+        return 2;
+    }
+
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0) {
+        return 2;
+    }
+
+    // BMI1 AVX2 BMI2
+    if ((ebx & 0x128U) != 0x128U) {
+        return 2;
+    }
+
+    // AVX512F AVX512DQ AVX512CD AVX512BW AVX512VL and opmask ZMM_Hi256 Hi16_ZMM state are enabled by the operating system
+    if ((ebx & 0xD0030000U) != 0xD0030000U || (xcr0 & 0xE6U) != 0xE6U) {
+        return 3;
+    }
+
+    return 4;
+}
+#endif
+
 int main(int argc, char* argv[]) {
     char selfExecPath[PATH_MAX];
 
@@ -75,11 +134,50 @@ int main(int argc, char* argv[]) {
 
     ////////////////////////////////////////////////////
 
+    // the glibc-hwcaps variants of the bundled shared libraries are preferred if the running cpu supports them
+    // https://sourceware.org/glibc/wiki/Release/2.33#New_glibc-hwcaps_subdirectories_in_the_library_search_path
+
+    char libraryPathList[PATH_MAX * 4];
+
+    int libraryPathListLength = 0;
+
+#if defined (__x86_64__)
+    for (int level = x86_64_level(); level >= 2; level--) {
+        ret = snprintf(libraryPathList + libraryPathListLength, sizeof(libraryPathList) - libraryPathListLength, "%s/glibc-hwcaps/x86-64-v%d:", libraryPath, level);
+
+        if (ret < 0) {
+            perror(NULL);
+            return 2;
+        }
+
+        if ((size_t)ret >= sizeof(libraryPathList) - libraryPathListLength) {
+            fprintf(stderr, "library path list is too long.\n");
+            return 2;
+        }
+
+        libraryPathListLength += ret;
+    }
+#endif
+
+    ret = snprintf(libraryPathList + libraryPathListLength, sizeof(libraryPathList) - libraryPathListLength, "%s", libraryPath);
+
+    if (ret < 0) {
+        perror(NULL);
+        return 2;
+    }
+
+    if ((size_t)ret >= sizeof(libraryPathList) - libraryPathListLength) {
+        fprintf(stderr, "library path list is too long.\n");
+        return 2;
+    }
+
+    ////////////////////////////////////////////////////
+
     char* argv2[argc + 6];
 
     argv2[0] = dynamicLoaderPath;
     argv2[1] = (char*)"--library-path";
-    argv2[2] = libraryPath;
+    argv2[2] = libraryPathList;
     argv2[3] = (char*)"--argv0";
     argv2[4] = selfExecPath;
     argv2[5] = realExePath;